@@ -0,0 +1,94 @@
+// Throughput benchmark for the Monte Carlo engine.
+// Runs the engine on a fixed set of seeded game states for each
+// supported game and reports how many analysis requests and
+// playouts per second it sustains.
+
+#include "mcengine.hh"
+#include <bitset>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+
+
+// Deals a random game state where the first n_turns turns have
+// already been played.
+template <class Rules>
+GameState<Rules>
+randomState(std::mt19937& gen, const int n_turns)
+{
+    std::array<int, Rules::n_cards> cards;
+    std::iota(cards.begin(), cards.end(), 0);
+    std::ranges::shuffle(cards, gen);
+    // The trump card is the last card of the deck.
+    const int trump_card = cards.back();
+    std::vector<int> hand(cards.begin(), cards.begin() + Rules::hand_size);
+    std::bitset<Rules::n_cards> spent_cards;
+    for (int i = 0; i < n_turns * Rules::n_players; ++i)
+    {
+        spent_cards.set(cards.at(Rules::hand_size + i));
+    }
+    const int first_player = std::uniform_int_distribution(
+        0, Rules::n_players - 1)(gen);
+    return GameState<Rules>{
+        {}, std::move(hand), spent_cards, first_player, trump_card};
+}
+
+// Runs n_requests analyses of n_games playouts each and prints
+// the throughput. The checksum only depends on the seeds, so it
+// can be used to check that two builds compute the same thing.
+template <class Rules>
+void
+benchmark(const char* name, const int n_requests, const int n_games)
+{
+    constexpr int n_turns =
+        (Rules::n_cards - Rules::n_players * Rules::hand_size) / Rules::n_players;
+    std::mt19937 gen;
+    std::vector<GameState<Rules>> states;
+    states.reserve(n_requests);
+    for (int i = 0; i < n_requests; ++i)
+    {
+        // Cycle through early, middle and late game states.
+        states.push_back(randomState<Rules>(gen, (i % 3) * n_turns / 3));
+    }
+
+    double checksum = 0.0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n_requests; ++i)
+    {
+        MonteCarloEngine<Rules> engine{n_games, static_cast<unsigned>(i)};
+        double ps[Rules::hand_size];
+        engine.run(states[i], ps);
+        checksum = std::accumulate(std::begin(ps), std::end(ps), checksum);
+    }
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    const double n_playouts = static_cast<double>(n_requests) * n_games;
+    std::cout << name << ": "
+        << n_requests / elapsed.count() << " requests/s, "
+        << n_playouts / elapsed.count() << " playouts/s"
+        << " (checksum " << checksum << ")\n";
+}
+
+//------------------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+    if (argc > 3)
+    {
+        std::cerr <<
+            "Usage: bench [n_requests] [n_games]\n" <<
+            "Example:\n" <<
+            "    bench 1000 1024\n";
+        return EXIT_FAILURE;
+    }
+    const int n_requests = argc > 1 ? std::atoi(argv[1]) : 1'000;
+    const int n_games = argc > 2 ? std::atoi(argv[2]) : 1'024;
+
+    std::cout << "engine kernel: " << kernelName(engineKernel()) << '\n';
+    benchmark<Briscola>("briscola", n_requests, n_games);
+    benchmark<BriscolaFour>("briscola a 4", n_requests, n_games);
+}
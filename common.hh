@@ -13,15 +13,19 @@
 //
 
 #include "mcengine.hh"
+#include "trace.hh"
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
 #include <boost/beast/version.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/config.hpp>
+#include <charconv>
 #include <cstdlib>
 //#include <format>  // enable after updating GCC
 #include <iostream>
 #include <memory>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 
 namespace beast = boost::beast;         // from <boost/beast.hpp>
@@ -105,7 +109,64 @@ path_cat(
     return result;
 }
 
+// Handle a tracing control request (see trace.hh):
+//   /trace/on[?every=N]  start tracing, sampling one request every N
+//   /trace/off           stop tracing
+//   /trace/dump          return the recorded spans as Chrome trace Json
+// Returns the Json body of the response, or an empty string if the
+// target is not a known tracing command. Throws std::invalid_argument
+// if N is not a positive integer.
+std::string
+trace_control(beast::string_view target)
+{
+    const auto query_pos = target.find('?');
+    const beast::string_view command = target.substr(0, query_pos);
+    if(command == "/trace/on")
+    {
+        unsigned every = 1;
+        beast::string_view query = query_pos == beast::string_view::npos
+            ? beast::string_view{} : target.substr(query_pos + 1);
+        while(! query.empty())
+        {
+            const auto amp_pos = query.find('&');
+            const beast::string_view param = query.substr(0, amp_pos);
+            query = amp_pos == beast::string_view::npos
+                ? beast::string_view{} : query.substr(amp_pos + 1);
+            if(! param.starts_with("every="))
+            {
+                continue;
+            }
+            const beast::string_view value = param.substr(6);
+            const char* const last = value.data() + value.size();
+            const auto [ptr, ec] = std::from_chars(value.data(), last, every);
+            if(ec != std::errc{} || ptr != last || every == 0)
+            {
+                throw std::invalid_argument(
+                    "every must be a positive integer, got '"
+                    + std::string(value) + "'");
+            }
+        }
+        trace::enable(every);
+        return "{\"enabled\":true,\"every\":"
+            + std::to_string(trace::every()) + "}";
+    }
+    if(command == "/trace/off")
+    {
+        trace::disable();
+        return "{\"enabled\":false}";
+    }
+    if(command == "/trace/dump")
+    {
+        std::ostringstream os;
+        trace::dump(os);
+        return os.str();
+    }
+    return {};
+}
+
 // Return a response for the given request.
+// The tracing control targets are only served if allow_trace_control
+// is set (the server sets it for loopback clients only).
 //
 // The concrete type of the response message (which depends on the
 // request), is type-erased in message_generator.
@@ -114,7 +175,8 @@ http::message_generator
 handle_request(
     beast::string_view doc_root,
     beast::string_view file_path,
-    http::request<Body, http::basic_fields<Allocator>>&& req)
+    http::request<Body, http::basic_fields<Allocator>>&& req,
+    bool allow_trace_control)
 {
     // Returns a bad request response
     const auto bad_request =
@@ -171,6 +233,34 @@ handle_request(
         return bad_request("Illegal request-target");
     }
 
+    // Tracing control.
+    if(req.method() == http::verb::get && req.target().starts_with("/trace/"))
+    {
+        if(!allow_trace_control)
+        {
+            return not_found(req.target());
+        }
+        std::string body;
+        try
+        {
+            body = trace_control(req.target());
+        }
+        catch(const std::invalid_argument& e)
+        {
+            return bad_request(e.what());
+        }
+        if(body.empty())
+        {
+            return not_found(req.target());
+        }
+        http::response<http::string_body> res{http::status::ok, req.version(), body};
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::content_type, "application/json");
+        res.content_length(body.size());
+        res.keep_alive(req.keep_alive());
+        return res;
+    }
+
     // Build the path to the requested file
     std::string path = path_cat(doc_root, req.target());
     if(req.target().back() == '/')
@@ -230,10 +320,15 @@ handle_request(
         // Respond to POST request
         case http::verb::post:
         {
-            GameState game = GameState::fromJson(req);
-            MonteCarloEngine engine;
-            double ps[3];
+            const auto game = [&req]
+            {
+                trace::Span span{"GameState::fromJson"};
+                return GameState<Briscola>::fromJson(req);
+            }();
+            MonteCarloEngine<Briscola> engine;
+            double ps[Briscola::hand_size];
             engine.run(game, ps);
+            trace::Span span{"serialize"};
             // TODO enable after updating GCC
             /*const std::string ps_str = std::format(
                 "{\"ps\":[{},{},{}]}", ps[0], ps[1], ps[2]);
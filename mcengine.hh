@@ -3,8 +3,13 @@
 // Implementation of the Monte Carlo game search engine.
 // We need to include boost/json/src.hpp to import boost/json
 // as header-only library.
+// The game state, the evaluator and the engine are templated
+// on a rules policy (see rules.hh), so that each game gets its
+// own specialized playout kernel.
 #include "boost/json/fwd.hpp"
 #include "boost/json/value_to.hpp"
+#include "rules.hh"
+#include "trace.hh"
 #include <bits/ranges_algo.h>
 #include <bits/ranges_algobase.h>
 #include <boost/json/src.hpp>
@@ -13,6 +18,8 @@
 #include <algorithm>
 #include <array>
 #include <bitset>
+#include <cstdlib>
+#include <iostream>
 #include <random>
 #include <ranges>
 #include <string_view>
@@ -22,6 +29,92 @@
 
 namespace http = boost::beast::http;
 
+// The playout loop is the engine kernel. When the engine is built
+// with ENGINE_MULTIVERSION (as in the release build) it is compiled
+// for several instruction sets and the best one for the CPU is used,
+// so that a single portable binary runs close to a -march=native
+// build. The kernels are flattened: everything they call (shuffle,
+// random number generator, evaluator) is inlined, otherwise it would
+// only be compiled for the baseline instruction set.
+//
+// The environment variable ENGINE_KERNEL=<name> selects another
+// kernel supported by the CPU. The release build uses it to collect
+// a profile for every kernel, as each has its own profile counters.
+#if defined(ENGINE_MULTIVERSION) && defined(__x86_64__) && defined(__GNUC__)
+#define ENGINE_MULTIVERSION_X86
+#define ENGINE_KERNEL __attribute__((flatten))
+#define ENGINE_KERNEL_FOR(arch) __attribute__((flatten, target(arch)))
+#else
+#define ENGINE_KERNEL
+#endif
+
+// Instruction sets the engine kernel can be compiled for.
+enum class Kernel
+{
+    x86_64,     // Baseline.
+    x86_64_v3,  // AVX2.
+    x86_64_v4   // AVX-512.
+};
+
+inline const char* kernelName(const Kernel kernel)
+{
+    switch (kernel)
+    {
+    case Kernel::x86_64_v3:
+        return "x86-64-v3";
+    case Kernel::x86_64_v4:
+        return "x86-64-v4";
+    default:
+        return "default";
+    }
+}
+
+// Returns whether this build has the kernel and the CPU can run it.
+inline bool kernelSupported(const Kernel kernel)
+{
+    switch (kernel)
+    {
+#ifdef ENGINE_MULTIVERSION_X86
+    case Kernel::x86_64_v3:
+        return __builtin_cpu_supports("x86-64-v3");
+    case Kernel::x86_64_v4:
+        return __builtin_cpu_supports("x86-64-v4");
+#endif
+    case Kernel::x86_64:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Returns the engine kernel used by this process: the one named by
+// ENGINE_KERNEL, or else the best one supported.
+inline Kernel engineKernel()
+{
+    static const Kernel selected = []
+    {
+        constexpr std::array kernels{
+            Kernel::x86_64_v4, Kernel::x86_64_v3, Kernel::x86_64};
+        const Kernel best = *std::ranges::find_if(kernels, kernelSupported);
+        const char* const name = std::getenv("ENGINE_KERNEL");
+        if (name == nullptr || *name == '\0')
+        {
+            return best;
+        }
+        const auto it = std::ranges::find_if(kernels,
+            [name](const Kernel k) { return std::string_view{name} == kernelName(k); });
+        if (it == kernels.end() || !kernelSupported(*it))
+        {
+            std::cerr << "ENGINE_KERNEL=" << name << " is not available, using "
+                << kernelName(best) << '\n';
+            return best;
+        }
+        return *it;
+    }();
+    return selected;
+}
+
+template <class Rules>
 class GameState
 {
 public:
@@ -37,16 +130,32 @@ public:
         return GameState{std::move(v)};
     }
 
+    // Builds a game state from its components, for callers that
+    // do not go through the Json interface (e.g. benchmarks).
+    GameState(
+        const std::array<int, Rules::n_teams>& points,
+        std::vector<int> hand,
+        const std::bitset<Rules::n_cards>& spent_cards,
+        const int first_player,
+        const int trump_card)
+        :
+        m_points{points},
+        m_hand{std::move(hand)},
+        m_spent_cards{spent_cards},
+        m_first_player{first_player},
+        m_trump_card{trump_card}
+    {}
+
     // TODO replace with static vector/array.
     // Returns a vector with the cards still in the deck, including
-    // those that could be in the opponent's hand. The order is not
+    // those that could be in the opponents' hands. The order is not
     // important as we do not know what are the cards outstanding,
     // except for the last card in the deck which is known.
     std::vector<int> deckCards() const
     {
         std::vector<int> cards;
-        cards.reserve(40);
-        for(int i = 0; i < 40; ++i)
+        cards.reserve(Rules::n_cards);
+        for(int i = 0; i < Rules::n_cards; ++i)
         {
             if ((i != m_trump_card)
                 && (!m_spent_cards.test(i))
@@ -63,7 +172,9 @@ public:
     // Returns how many hands (or turns) are left to play.
     int nHandsLeft() const
     {
-        return (40 - 2 * m_hand.size() - m_spent_cards.count()) / 2;
+        return static_cast<int>(Rules::n_cards
+            - Rules::n_players * m_hand.size()
+            - m_spent_cards.count()) / Rules::n_players;
     }
 
     const std::vector<int>& playerHand() const
@@ -81,7 +192,7 @@ public:
         return m_trump_card;
     }
 
-    // Returns the number of points of the first player.
+    // Returns the number of points of the first player's team.
     int points() const
     {
         return m_points.at(0);
@@ -90,7 +201,8 @@ public:
 private:
     GameState(boost::json::value&& v)
         :
-        m_points{boost::json::value_to<std::array<int, 2>>(v.at(key_points))},
+        m_points{boost::json::value_to<std::array<int, Rules::n_teams>>(
+            v.at(key_points))},
         m_hand{boost::json::value_to<std::vector<int>>(v.at(key_hand))},
         m_first_player(v.at(key_first_player).as_int64()),
         m_trump_card(v.at(key_trump_card).as_int64())
@@ -110,137 +222,170 @@ private:
     static constexpr std::string_view key_trump_card {"trump_card"};
     static constexpr std::string_view key_spent_cards {"spent_cards"};
 
-    std::array<int, 2> m_points;
+    std::array<int, Rules::n_teams> m_points;
     std::vector<int> m_hand;
-    std::bitset<40> m_spent_cards;
+    std::bitset<Rules::n_cards> m_spent_cards;
     int m_first_player;
     int m_trump_card;
 };
 
 
+template <class Rules>
 class Evaluator
 {
 public:
-// Returns the points obtained by player 0 if it plays the
-// sequence of cards `sequence0` when the game is in a state
-// given by `game` and the deck is in a state given by `deck`
-// and the opponent plays the cards of `sequence1`.
+    // Sequence of cards played by each player. Each entry is the
+    // index of the card in the player's hand at that turn.
+    using Plays = std::array<std::vector<int>, Rules::n_players>;
+
+// Returns the points obtained by the team of player 0 if each
+// player i plays the sequence of cards `plays[i]` when the game
+// is in a state given by `game` and the deck is in a state given
+// by `deck`.
     static int evaluatePlay(
-        const GameState& game,
+        const GameState<Rules>& game,
         const std::vector<int>& deck,
-        const std::vector<int>& sequence0,
-        const std::vector<int>& sequence1
+        const Plays& plays
+    );
+
+    // Returns the position in `cards` of the card that takes the
+    // hand and the points of the hand. Cards are listed in the
+    // order in which they are played.
+    static std::pair<int, int> evaluateHand(
+        const std::array<int, Rules::n_players>& cards, int trump_card
     );
 
 private:
-    // Calculates if the first player won the hand and the number of
-    // points of the hand.
-    static std::pair<bool, int> evaluateHand(
-        int c0, int c1, int trump_card
+    // Same as evaluateHand, with the trump suit already computed.
+    static std::pair<int, int> resolveHand(
+        const std::array<int, Rules::n_players>& cards, int trump_suit
     );
 
-    // Strength of each card, from ace to king.
-    static constexpr int strength[]{9, 0, 8, 1, 2, 3, 4, 5, 6, 7};
-    // Value of each card, from ace to king.
-    static constexpr int value[]{11, 0, 10, 0, 0, 0, 0, 2, 3, 4};
+    // Returns true if card c beats card best, the strongest card
+    // played so far in the hand.
+    static bool beats(int c, int best, int trump_suit);
+
+    static constexpr int n_faces = Rules::n_cards / Rules::n_suits;
+
+    // The tables and the team of each player are used as indices:
+    // reject an inconsistent policy at compile time.
+    static_assert(Rules::n_cards % Rules::n_suits == 0,
+        "every suit must have the same number of cards");
+    static_assert(Rules::strength.size() == n_faces
+        && Rules::value.size() == n_faces,
+        "strength and value need one entry per face");
+    static_assert([]
+    {
+        for (int p = 0; p < Rules::n_players; ++p)
+        {
+            if (Rules::team(p) < 0 || Rules::team(p) >= Rules::n_teams)
+            {
+                return false;
+            }
+        }
+        return true;
+    }(), "team(i) must be in [0, n_teams) for every player");
 };
 
 
-/* static */ int Evaluator::evaluatePlay(
-    const GameState& game,
+template <class Rules>
+/* static */ int Evaluator<Rules>::evaluatePlay(
+    const GameState<Rules>& game,
     const std::vector<int>& deck,
-    const std::vector<int>& sequence0,
-    const std::vector<int>& sequence1
+    const Plays& plays
 )
 {
-    std::array<int, 3> hand0;
-    std::ranges::copy_n(game.playerHand().cbegin(), 3, hand0.begin());
-    // We choose to use the first three cards of deck as the
-    // cards in opponent's hand.
-    // TODO what if deck has < 3 cards?
-    std::array<int, 3> hand1{deck.at(0), deck.at(1), deck.at(2)};
+    std::array<std::array<int, Rules::hand_size>, Rules::n_players> hands;
+    std::ranges::copy_n(
+        game.playerHand().cbegin(), Rules::hand_size, hands[0].begin());
+    // We choose to use the first cards of deck as the cards in
+    // the opponents' hands.
+    // TODO what if deck has too few cards?
+    auto it_next_card = deck.cbegin();
+    for (int p = 1; p < Rules::n_players; ++p)
+    {
+        std::copy_n(it_next_card, Rules::hand_size, hands[p].begin());
+        it_next_card += Rules::hand_size;
+    }
+    const int trump_suit = game.trumpCard() / n_faces;
     int first_player = game.firstPlayer();
-    auto it_next_card = deck.cbegin() + 3;
-    auto it_p0 = sequence0.cbegin();
-    auto it_p1 = sequence1.cbegin();
     int pts = game.points();
-    std::pair<bool, int> hand_res;
-    while (it_p0 != sequence0.end())
+    const std::size_t n_hands = plays[0].size();
+    for (std::size_t t = 0; t < n_hands; ++t)
     {
-        const int c0 = hand0.at(*it_p0);
-        const int c1 = hand1.at(*it_p1);
-        if (first_player == 0)
+        // Cards of the hand in the order in which they are played.
+        std::array<int, Rules::n_players> cards;
+        int p = first_player;
+        for (int k = 0; k < Rules::n_players; ++k)
         {
-            hand_res = evaluateHand(c0, c1, game.trumpCard());
-            first_player = static_cast<int>(hand_res.first);
+            cards[k] = hands[p][plays[p][t]];
+            if (++p == Rules::n_players)
+            {
+                p = 0;
+            }
         }
-        else
+        const auto [k_winner, hand_pts] = resolveHand(cards, trump_suit);
+        int winner = first_player + k_winner;
+        if (winner >= Rules::n_players)
         {
-            hand_res = evaluateHand(c1, c0, game.trumpCard());
-            first_player = static_cast<int>(!hand_res.first);
+            winner -= Rules::n_players;
         }
-        if (first_player == 0)
+        if (Rules::team(winner) == Rules::team(0))
         {
             // Hand won. Increment points.
-            pts += hand_res.second;
+            pts += hand_pts;
         }
+        first_player = winner;
         // Update cards in hand.
-        hand0.at(*it_p0) = *it_next_card++;
-        hand1.at(*it_p1) = *it_next_card++;
-        // Update iterators.
-        ++it_p0;
-        ++it_p1;
+        for (int p = 0; p < Rules::n_players; ++p)
+        {
+            hands[p][plays[p][t]] = *it_next_card++;
+        }
     }
     return pts;
 }
 
-// Calculates if the first player won the hand and the number of
-// points of the hand.
-/* static */ std::pair<bool, int> Evaluator::evaluateHand(
-    const int c0, const int c1, const int trump_card
+template <class Rules>
+/* static */ std::pair<int, int> Evaluator<Rules>::evaluateHand(
+    const std::array<int, Rules::n_players>& cards, const int trump_card
 )
 {
-    const int suit0 = c0 / 10, suit1 = c1 / 10;
-    // Face value
-    const int fv0 = c0 % 10, fv1 = c1 % 10;
-    // Strength
-    const int s0 = strength[fv0], s1 = strength[fv1];
-    // Point value
-    const int v0 = value[fv0], v1 = value[fv1];
-    // Same suit as the trump card?
-    const bool is_trump_0 = (trump_card / 10) == suit0;
-    const bool is_trump_1 = (trump_card / 10) == suit1;
-    if (is_trump_0)
+    return resolveHand(cards, trump_card / n_faces);
+}
+
+template <class Rules>
+/* static */ std::pair<int, int> Evaluator<Rules>::resolveHand(
+    const std::array<int, Rules::n_players>& cards, const int trump_suit
+)
+{
+    int winner = 0;
+    int hand_pts = Rules::value[cards[0] % n_faces];
+    for (int k = 1; k < Rules::n_players; ++k)
     {
-        if (is_trump_1)
+        hand_pts += Rules::value[cards[k] % n_faces];
+        if (beats(cards[k], cards[winner], trump_suit))
         {
-            // Both cards are trumps. The highest one wins.
-            return {s0 > s1, v0 + v1};
-        }
-        else
-        {
-            // First player wins.
-            return {true, v0 + v1};
+            winner = k;
         }
     }
-    else
+    return {winner, hand_pts};
+}
+
+// Returns true if card c beats card best, the strongest card
+// played so far in the hand.
+template <class Rules>
+/* static */ bool Evaluator<Rules>::beats(
+    const int c, const int best, const int trump_suit
+)
+{
+    const int suit = c / n_faces, best_suit = best / n_faces;
+    if (suit == best_suit)
     {
-        if (is_trump_1)
-        {
-            // Second player wins.
-            return {false, v0 + v1};
-        }
-        else if (suit0 == suit1)
-        {
-            // Same suit. Highest card wins.
-            return {s0 > s1, v0 + v1};
-        }
-        else
-        {
-            // Different suit. First player wins.
-            return {true, v0 + v1};
-        }
+        // Same suit. Highest card wins.
+        return Rules::strength[c % n_faces] > Rules::strength[best % n_faces];
     }
+    // Different suit. Only a trump can take the hand.
+    return suit == trump_suit;
 }
 
 
@@ -252,21 +397,65 @@ private:
 // fraction of games that are won if that card is played first.
 // TODO rename this class: SerialEngine, which implements a
 // MonteCarloEngine interface.
+template <class Rules>
 class MonteCarloEngine
 {
 public:
-    MonteCarloEngine(int n_games = 1'024)
-      : m_ngames{n_games}
+    MonteCarloEngine(
+        int n_games = 1'024,
+        std::mt19937::result_type seed = std::mt19937::default_seed)
+      : m_ngames{n_games},
+        m_gen{seed}
     {}
 
-    void run(const GameState& game, double ps[3]);
+    // Fills ps with the probability of winning when playing each
+    // card in hand. Returns false if the answer is trivial (last
+    // hand, or game already won) and no playouts were run.
+    bool run(const GameState<Rules>& game, double (&ps)[Rules::hand_size]);
 
 private:
-    // Generates a random playing strategy with n_cards cards.
-    // Returns a vector of ints having values in [0, 1, 2] that
-    // encode which card of the player's hand is played at each
-    // turn.
-    std::vector<int> randomPlay(int n_cards) const;
+    // Simulates m_ngames random games issuing from `game`, where
+    // deck_cards are the cards not seen by player 0 with the trump
+    // card last. For each card in hand, counts in n_games how many
+    // games started with that card and in n_wins how many of those
+    // were won. Runs the kernel given by engineKernel().
+    void playouts(
+        const GameState<Rules>& game,
+        std::vector<int>& deck_cards,
+        std::array<double, Rules::hand_size>& n_wins,
+        std::array<double, Rules::hand_size>& n_games);
+
+    // The playouts compiled for each instruction set.
+    ENGINE_KERNEL void playoutsDefault(
+        const GameState<Rules>& game,
+        std::vector<int>& deck_cards,
+        std::array<double, Rules::hand_size>& n_wins,
+        std::array<double, Rules::hand_size>& n_games);
+#ifdef ENGINE_MULTIVERSION_X86
+    ENGINE_KERNEL_FOR("arch=x86-64-v3") void playoutsV3(
+        const GameState<Rules>& game,
+        std::vector<int>& deck_cards,
+        std::array<double, Rules::hand_size>& n_wins,
+        std::array<double, Rules::hand_size>& n_games);
+    ENGINE_KERNEL_FOR("arch=x86-64-v4") void playoutsV4(
+        const GameState<Rules>& game,
+        std::vector<int>& deck_cards,
+        std::array<double, Rules::hand_size>& n_wins,
+        std::array<double, Rules::hand_size>& n_games);
+#endif
+
+    // The playout loop, inlined in each kernel.
+    void simulate(
+        const GameState<Rules>& game,
+        std::vector<int>& deck_cards,
+        std::array<double, Rules::hand_size>& n_wins,
+        std::array<double, Rules::hand_size>& n_games);
+
+    // Generates a random playing strategy, one card per entry of
+    // play. The entries take values in [0, hand_size) and encode
+    // which card of the player's hand is played at each turn.
+    // The buffer is reused across playouts to avoid allocations.
+    void randomPlay(std::vector<int>& play) const;
 
     // Number of games to simulate.
     int m_ngames;
@@ -274,76 +463,163 @@ private:
 };
 
 
-void MonteCarloEngine::run(const GameState& game, double ps[3])
+template <class Rules>
+bool MonteCarloEngine<Rules>::run(
+    const GameState<Rules>& game, double (&ps)[Rules::hand_size])
 {
+    trace::Span span{"MonteCarloEngine::run"};
     // Zero-out the memory buffer.
-    ps[0] = 0.0;
-    ps[1] = 0.0;
-    ps[2] = 0.0;
+    std::ranges::fill(ps, 0.0);
 
     if (game.nHandsLeft() <= 1)
     {
         // Just play whatever card you have in hand.
-        return;
+        return false;
     }
-    if (game.points() > 60)
+    if (Rules::isWin(game.points()))
     {
         // Game already won.
-        ps[0] = 1.0;
-        ps[1] = 1.0;
-        ps[2] = 1.0;
-        return;
+        std::ranges::fill(ps, 1.0);
+        return false;
     }
 
     // TODO offload to a pure function for parallel execution?
-    std::vector<int> deck_cards = game.deckCards();
+    std::vector<int> deck_cards;
+    {
+        trace::Span deck_span{"deckCards"};
+        deck_cards = game.deckCards();
+    }
+    // Number of games played and won that started with each card
+    // in hand.
+    std::array<double, Rules::hand_size> n_wins{};
+    std::array<double, Rules::hand_size> n_games{};
+    {
+        // The time spent in the shuffle, randomPlay and evaluatePlay
+        // is traced as a whole: a span per playout would cost too much.
+        trace::Span playouts_span{"playouts"};
+        playouts(game, deck_cards, n_wins, n_games);
+    }
+    // Convert number of wins to probabilities.
+    for (int i = 0; i < Rules::hand_size; ++i)
+    {
+        ps[i] = n_wins[i] / n_games[i];
+    }
+    return true;
+}
+
+
+template <class Rules>
+void MonteCarloEngine<Rules>::playouts(
+    const GameState<Rules>& game,
+    std::vector<int>& deck_cards,
+    std::array<double, Rules::hand_size>& n_wins,
+    std::array<double, Rules::hand_size>& n_games)
+{
+    switch (engineKernel())
+    {
+#ifdef ENGINE_MULTIVERSION_X86
+    case Kernel::x86_64_v4:
+        playoutsV4(game, deck_cards, n_wins, n_games);
+        break;
+    case Kernel::x86_64_v3:
+        playoutsV3(game, deck_cards, n_wins, n_games);
+        break;
+#endif
+    default:
+        playoutsDefault(game, deck_cards, n_wins, n_games);
+    }
+}
+
+template <class Rules>
+ENGINE_KERNEL void MonteCarloEngine<Rules>::playoutsDefault(
+    const GameState<Rules>& game,
+    std::vector<int>& deck_cards,
+    std::array<double, Rules::hand_size>& n_wins,
+    std::array<double, Rules::hand_size>& n_games)
+{
+    simulate(game, deck_cards, n_wins, n_games);
+}
+
+#ifdef ENGINE_MULTIVERSION_X86
+template <class Rules>
+ENGINE_KERNEL_FOR("arch=x86-64-v3") void MonteCarloEngine<Rules>::playoutsV3(
+    const GameState<Rules>& game,
+    std::vector<int>& deck_cards,
+    std::array<double, Rules::hand_size>& n_wins,
+    std::array<double, Rules::hand_size>& n_games)
+{
+    simulate(game, deck_cards, n_wins, n_games);
+}
+
+template <class Rules>
+ENGINE_KERNEL_FOR("arch=x86-64-v4") void MonteCarloEngine<Rules>::playoutsV4(
+    const GameState<Rules>& game,
+    std::vector<int>& deck_cards,
+    std::array<double, Rules::hand_size>& n_wins,
+    std::array<double, Rules::hand_size>& n_games)
+{
+    simulate(game, deck_cards, n_wins, n_games);
+}
+#endif
+
+template <class Rules>
+void MonteCarloEngine<Rules>::simulate(
+    const GameState<Rules>& game,
+    std::vector<int>& deck_cards,
+    std::array<double, Rules::hand_size>& n_wins,
+    std::array<double, Rules::hand_size>& n_games)
+{
     // deck_cards are all cards except those already played
     // and those in player0's hand
     const std::size_t ncards = deck_cards.size();
     auto hidden_deck = std::ranges::take_view(deck_cards, ncards - 1);
 
-    // Number of games played that started with card 0, 1, or 2.
-    double n_games[] {0.0, 0.0, 0.0};
+    typename Evaluator<Rules>::Plays plays;
+    for (auto& play : plays)
+    {
+        play.resize(game.nHandsLeft());
+    }
 
     // TODO replace with an algorithm?
     for (int i = 0; i < m_ngames; ++i)
     {
         std::ranges::shuffle(hidden_deck, m_gen);
-        const std::vector<int> play0 = randomPlay(game.nHandsLeft());
-        const std::vector<int> play1 = randomPlay(game.nHandsLeft());
-        const int pts0 = Evaluator::evaluatePlay(game, deck_cards, play0, play1);
-        // Index of the first card played. Must be 0, 1, or 2.
-        const int idx = play0.front();
+        for (auto& play : plays)
+        {
+            randomPlay(play);
+        }
+        const int pts0 = Evaluator<Rules>::evaluatePlay(game, deck_cards, plays);
+        // Index of the first card played. Must be in [0, hand_size).
+        const int idx = plays[0].front();
         // Count how many games started with card idx.
         n_games[idx] += 1.0;
         // Update the number of wins.
-        if (pts0 >= 60)
+        if (Rules::isWin(pts0))
         {
-            ps[idx] += 1.0;
+            n_wins[idx] += 1.0;
         }
     }
-    // Convert number of wins to probabilities.
-    ps[0] /= n_games[0];
-    ps[1] /= n_games[1];
-    ps[2] /= n_games[2];
 }
 
 
-// Generates a random playing strategy with n_cards cards.
-// Returns a vector of ints having values in [0, 1, 2] that
-// encode which card of the player's hand is played at each
-// turn.
-std::vector<int> MonteCarloEngine::randomPlay(const int n_hands) const
+// Generates a random playing strategy, one card per entry of
+// play. The entries take values in [0, hand_size) and encode
+// which card of the player's hand is played at each turn.
+template <class Rules>
+void MonteCarloEngine<Rules>::randomPlay(std::vector<int>& play) const
 {
-    std::vector<int> play(n_hands);
-    std::uniform_int_distribution dist(0, 2), dist2(0, 1);
-    for (int i = 0; i < n_hands - 2; ++i)
+    const int n_hands = static_cast<int>(play.size());
+    std::uniform_int_distribution dist(0, Rules::hand_size - 1);
+    const int n_full = n_hands - (Rules::hand_size - 1);
+    for (int i = 0; i < n_full; ++i)
     {
-        play.at(i) = dist(m_gen);
+        play[i] = dist(m_gen);
+    }
+    // Assumption: n_hands >= 2. In the last turns there are
+    // fewer cards to choose from.
+    for (int i = std::max(n_full, 0); i < n_hands - 1; ++i)
+    {
+        play[i] = std::uniform_int_distribution(0, n_hands - 1 - i)(m_gen);
     }
-    // Assumption: n_hands >= 2.
-    play.at(n_hands - 2) = dist2(m_gen);
     play.back() = 0;
-    return play;
 }
-
@@ -0,0 +1,77 @@
+#pragma once
+
+// Rules policies for the Italian trick-taking games supported by
+// the Monte Carlo engine. Each policy is a stateless class with
+// constexpr tables, so that GameState, Evaluator and
+// MonteCarloEngine compile into a fully specialized kernel for
+// every game, without any runtime dispatch in the playout loop.
+//
+// A rules policy must provide:
+// - n_cards, n_suits: size of the deck and number of suits. Card
+//   c has suit c / (n_cards / n_suits) and face c % (n_cards / n_suits).
+// - n_players, n_teams, hand_size: table layout. Player i plays
+//   for team team(i).
+// - strength, value: strength and point value of each face.
+// - isWin(points): whether a team with the given points won.
+//
+// Briscola chiamata is not supported. It is played by 5 players
+// with 8 cards each, and the bidder's partner is the holder of a
+// called card, so teams depend on the deal and are unknown to the
+// other players until the partner reveals itself. A fixed team(i)
+// cannot express that: the policy would need per-deal team
+// assignment, which GameState would carry and the engine would
+// sample in each playout along with the hidden hands, and a
+// bidding phase before the first hand.
+#include <array>
+
+
+// Briscola for two players.
+struct Briscola
+{
+    static constexpr int n_cards = 40;
+    static constexpr int n_suits = 4;
+    static constexpr int n_players = 2;
+    static constexpr int n_teams = 2;
+    static constexpr int hand_size = 3;
+
+    // Strength of each card, from ace to king.
+    static constexpr std::array<int, 10> strength{9, 0, 8, 1, 2, 3, 4, 5, 6, 7};
+    // Value of each card, from ace to king.
+    static constexpr std::array<int, 10> value{11, 0, 10, 0, 0, 0, 0, 2, 3, 4};
+
+    static constexpr int team(const int player)
+    {
+        return player;
+    }
+
+    // There are 120 points in the deck: 60 is enough not to lose.
+    static constexpr bool isWin(const int points)
+    {
+        return points >= 60;
+    }
+};
+
+
+// Briscola a 4: four players in two fixed teams, partners sit
+// opposite each other (players 0 and 2 against 1 and 3).
+struct BriscolaFour
+{
+    static constexpr int n_cards = 40;
+    static constexpr int n_suits = 4;
+    static constexpr int n_players = 4;
+    static constexpr int n_teams = 2;
+    static constexpr int hand_size = 3;
+
+    static constexpr std::array<int, 10> strength = Briscola::strength;
+    static constexpr std::array<int, 10> value = Briscola::value;
+
+    static constexpr int team(const int player)
+    {
+        return player % 2;
+    }
+
+    static constexpr bool isWin(const int points)
+    {
+        return Briscola::isWin(points);
+    }
+};
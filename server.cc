@@ -1,6 +1,10 @@
 #include "common.hh"
 #include <boost/beast.hpp>
 #include <iostream>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <string_view>
 #include <thread>
 
 namespace net = boost::asio;            // from <boost/asio.hpp>
@@ -22,11 +26,15 @@ do_session(
     // This buffer is required to persist across reads
     beast::flat_buffer buffer;
 
+    // Tracing control is only served to clients on this machine.
+    const bool is_local = socket.remote_endpoint(ec).address().is_loopback();
+
     for(;;)
     {
-        // Read a request
-        http::request<http::string_body> req;
-        http::read(socket, buffer, req, ec);
+        // Read the header of a request. On keep-alive connections this
+        // waits for the client, so it is not traced.
+        http::request_parser<http::string_body> parser;
+        http::read_header(socket, buffer, parser, ec);
         if(ec == http::error::end_of_stream)
         {
             break;
@@ -36,15 +44,41 @@ do_session(
             return fail(ec, "read");
         }
 
+        // A request has started arriving: decide if it is sampled.
+        // Tracing control requests are never traced, so that they
+        // neither show up in the dumps nor shift the sampling.
+        std::optional<trace::Request> trace_request;
+        if(! parser.get().target().starts_with("/trace/"))
+        {
+            trace_request.emplace("request");
+        }
+
+        // Read the rest of the request
+        {
+            trace::Span span{"http::read"};
+            http::read(socket, buffer, parser, ec);
+        }
+        if(ec)
+        {
+            return fail(ec, "read");
+        }
+        http::request<http::string_body> req = parser.release();
+
         // Handle request
-        http::message_generator msg =
-            handle_request(*doc_root, g_path, std::move(req));
+        http::message_generator msg = [&]
+        {
+            trace::Span span{"handle_request"};
+            return handle_request(*doc_root, g_path, std::move(req), is_local);
+        }();
 
         // Determine if we should close the connection
         bool keep_alive = msg.keep_alive();
 
         // Send the response
-        beast::write(socket, std::move(msg), ec);
+        {
+            trace::Span span{"beast::write"};
+            beast::write(socket, std::move(msg), ec);
+        }
 
         if(ec)
         {
@@ -64,17 +98,58 @@ do_session(
     // At this point the connection is closed gracefully
 }
 
+// Runs a seeded workload of analysis requests through handle_request,
+// without any network I/O. This is the training run of the
+// profile-guided release build (see the Makefile).
+void
+train(const int n_requests)
+{
+    std::mt19937 gen;
+    for(int i = 0; i < n_requests; ++i)
+    {
+        std::array<int, Briscola::n_cards> cards;
+        std::iota(cards.begin(), cards.end(), 0);
+        std::ranges::shuffle(cards, gen);
+        // Cycle through early, middle and late game states, in the
+        // format parsed by GameState::fromJson.
+        const int n_spent = 10 * (i % 3);
+        std::string body = "{\"points\":[0,0],\"hand\":["
+            + std::to_string(cards[0]) + ',' + std::to_string(cards[1])
+            + ',' + std::to_string(cards[2]) + "],\"first_to_play\":"
+            + std::to_string(i % 2) + ",\"trump_card\":"
+            + std::to_string(cards.back()) + ",\"spent_cards\":[";
+        for(int j = 0; j < n_spent; ++j)
+        {
+            body += (j ? "," : "") + std::to_string(cards[3 + j] + 1);
+        }
+        body += "]}";
+
+        http::request<http::string_body> req{http::verb::post, "/", 11};
+        req.body() = std::move(body);
+        req.prepare_payload();
+        // The response is discarded.
+        handle_request(".", g_path, std::move(req), false);
+    }
+}
+
 //------------------------------------------------------------------------------
 
 int main(int argc, char* argv[])
 {
     try
     {
+        if (argc == 3 && std::string_view{argv[1]} == "--train")
+        {
+            train(std::atoi(argv[2]));
+            return EXIT_SUCCESS;
+        }
+
         // Check command line arguments.
         if (argc != 4)
         {
             std::cerr <<
                 "Usage: server <address> <port> <doc_root>\n" <<
+                "       server --train <n_requests>\n" <<
                 "Example:\n" <<
                 "    server 0.0.0.0 8080 .\n";
             return EXIT_FAILURE;
@@ -0,0 +1,380 @@
+// Headless self-play tournament between two players, used to
+// measure how strong the engine's advice is and how the strength
+// trades off against the number of playouts.
+//
+// Every deal is seeded and played twice with the seats swapped, so
+// that both players get the same cards. Deals are spread over all
+// the cores. The result is the score of the first player (1 for a
+// win, 1/2 for a draw) with a 95% confidence interval, and the CPU
+// time each player spends per decision. Decisions where the engine
+// has nothing to search (random player, last hands, game already
+// won) take no time, so the time per engine search is also reported.
+
+#include "mcengine.hh"
+#include <atomic>
+#include <bitset>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// A player is either the Monte Carlo engine with a given number of
+// playouts per decision ("mc:<n_games>") or the random player of
+// briscola.html ("random").
+struct Player
+{
+    std::string name;
+    int n_games;  // 0 for the random player.
+};
+
+// Parses a player from the command line. Throws on bad input.
+Player
+parsePlayer(const std::string& s)
+{
+    if(s == "random")
+    {
+        return {s, 0};
+    }
+    if(s.starts_with("mc:"))
+    {
+        const int n_games = std::atoi(s.c_str() + 3);
+        if(n_games > 0)
+        {
+            return {s, n_games};
+        }
+    }
+    throw std::invalid_argument("unknown player '" + s + "'");
+}
+
+// Outcome of the games played by a worker thread, seen from the
+// first player of the tournament.
+struct Results
+{
+    int wins = 0;
+    int draws = 0;
+    int losses = 0;
+    // Sum and sum of squares of the mean score of each deal.
+    double score_sum = 0.0;
+    double score_sq_sum = 0.0;
+    // CPU time spent deciding, and number of decisions, per player.
+    std::array<double, 2> cpu_ns{};
+    std::array<long, 2> n_decisions{};
+    // Same, restricted to the decisions where the engine ran playouts.
+    std::array<double, 2> search_cpu_ns{};
+    std::array<long, 2> n_searches{};
+
+    Results& operator+=(const Results& r)
+    {
+        wins += r.wins;
+        draws += r.draws;
+        losses += r.losses;
+        score_sum += r.score_sum;
+        score_sq_sum += r.score_sq_sum;
+        for (int i = 0; i < 2; ++i)
+        {
+            cpu_ns[i] += r.cpu_ns[i];
+            n_decisions[i] += r.n_decisions[i];
+            search_cpu_ns[i] += r.search_cpu_ns[i];
+            n_searches[i] += r.n_searches[i];
+        }
+        return *this;
+    }
+};
+
+// CPU time used by the calling thread, in nanoseconds.
+double
+threadCpuTime()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Returns the index of the card to play from a hand of n_cards cards.
+// The engine player picks the card with the highest probability of
+// winning, breaking ties at random. When the engine has no advice
+// (near the end of the game) this is the same as the random player.
+// Sets searched to whether the engine ran playouts.
+template <class Rules>
+int
+chooseCard(
+    const Player& player,
+    const GameState<Rules>& view,
+    const int n_cards,
+    std::mt19937& gen,
+    bool& searched)
+{
+    searched = false;
+    if(player.n_games == 0 || n_cards < Rules::hand_size)
+    {
+        return std::uniform_int_distribution(0, n_cards - 1)(gen);
+    }
+    MonteCarloEngine<Rules> engine{player.n_games, gen()};
+    double ps[Rules::hand_size];
+    searched = engine.run(view, ps);
+    int choice = 0;
+    int n_best = 0;
+    double best = -1.0;
+    for(int i = 0; i < n_cards; ++i)
+    {
+        // A card never played first by the engine has ps = NaN.
+        const double p = std::isnan(ps[i]) ? -1.0 : ps[i];
+        if(p > best)
+        {
+            best = p;
+            choice = i;
+            n_best = 1;
+        }
+        else if(p == best
+            && std::uniform_int_distribution(0, n_best++)(gen) == 0)
+        {
+            choice = i;
+        }
+    }
+    return choice;
+}
+
+// Random streams of a deal: the shuffle of the deck, and the
+// players' own choices in each of the two games.
+enum class Stream : std::uint32_t
+{
+    deal,
+    play_first,
+    play_second
+};
+
+// Returns the generator of a stream of a deal. Mixing the three
+// values through seed_seq keeps the streams of different deals, and
+// of different tournament seeds, apart, so that deals are independent.
+std::mt19937
+makeGenerator(const std::uint32_t seed, const int deal, const Stream stream)
+{
+    std::seed_seq seq{
+        seed, static_cast<std::uint32_t>(deal), static_cast<std::uint32_t>(stream)};
+    return std::mt19937{seq};
+}
+
+// Plays a full game whose deck is shuffled by deal_gen. Team t is
+// played by players[player_ids[t]]; the player in seat 0 plays
+// first. The players' own random choices are drawn from gen. Returns
+// the points of each team and accumulates the decision times in
+// results.
+template <class Rules>
+std::array<int, Rules::n_teams>
+playGame(
+    const std::array<Player, 2>& players,
+    const std::array<int, 2>& player_ids,
+    std::mt19937 deal_gen,
+    std::mt19937 gen,
+    Results& results)
+{
+    static_assert(Rules::n_teams == 2);
+    std::vector<int> deck(Rules::n_cards);
+    std::iota(deck.begin(), deck.end(), 0);
+    std::ranges::shuffle(deck, deal_gen);
+    // As in briscola.html: deal from the top of the deck, the trump
+    // card is the one at the bottom and is drawn last.
+    const int trump_card = deck.front();
+    std::array<std::vector<int>, Rules::n_players> hands;
+    for(auto& hand : hands)
+    {
+        for(int i = 0; i < Rules::hand_size; ++i)
+        {
+            hand.push_back(deck.back());
+            deck.pop_back();
+        }
+    }
+
+    std::array<int, Rules::n_teams> points{};
+    std::bitset<Rules::n_cards> spent_cards;
+    int first_player = 0;
+    while(!hands[first_player].empty())
+    {
+        std::array<int, Rules::n_players> cards;
+        for(int k = 0; k < Rules::n_players; ++k)
+        {
+            const int p = (first_player + k) % Rules::n_players;
+            const int team = Rules::team(p);
+            // What the player knows, in the format of an analysis
+            // request from briscola.html.
+            const GameState<Rules> view{
+                {points[team], points[1 - team]},
+                hands[p],
+                spent_cards,
+                (first_player - p + Rules::n_players) % Rules::n_players,
+                trump_card};
+            const int id = player_ids[team];
+            bool searched;
+            const double start = threadCpuTime();
+            const int idx = chooseCard(
+                players[id], view, static_cast<int>(hands[p].size()), gen,
+                searched);
+            const double cpu_ns = threadCpuTime() - start;
+            results.cpu_ns[id] += cpu_ns;
+            results.n_decisions[id] += 1;
+            if(searched)
+            {
+                results.search_cpu_ns[id] += cpu_ns;
+                results.n_searches[id] += 1;
+            }
+            cards[k] = hands[p][idx];
+            hands[p].erase(hands[p].begin() + idx);
+            spent_cards.set(cards[k]);
+        }
+        const auto [winner, hand_pts] =
+            Evaluator<Rules>::evaluateHand(cards, trump_card);
+        first_player = (first_player + winner) % Rules::n_players;
+        points[Rules::team(first_player)] += hand_pts;
+        // The winner of the hand draws first.
+        for(int k = 0; k < Rules::n_players && !deck.empty(); ++k)
+        {
+            hands[(first_player + k) % Rules::n_players].push_back(deck.back());
+            deck.pop_back();
+        }
+    }
+    return points;
+}
+
+// Plays deals [0, n_deals) taking them from a shared counter, and
+// returns the results of the games played.
+template <class Rules>
+Results
+worker(
+    const std::array<Player, 2>& players,
+    const int n_deals,
+    const std::uint32_t seed,
+    std::atomic<int>& next_deal)
+{
+    Results results;
+    for(int deal = next_deal++; deal < n_deals; deal = next_deal++)
+    {
+        const std::mt19937 deal_gen = makeGenerator(seed, deal, Stream::deal);
+        double score = 0.0;
+        // Player 0 plays for team 0 (and leads the first hand),
+        // then the seats are swapped.
+        for(const int our_team : {0, 1})
+        {
+            const std::array<int, 2> ids{our_team, 1 - our_team};
+            const std::mt19937 gen = makeGenerator(seed, deal,
+                our_team == 0 ? Stream::play_first : Stream::play_second);
+            const auto points = playGame<Rules>(
+                players, ids, deal_gen, gen, results);
+            const int ours = points[our_team], theirs = points[1 - our_team];
+            if(ours > theirs)
+            {
+                ++results.wins;
+                score += 1.0;
+            }
+            else if(ours == theirs)
+            {
+                ++results.draws;
+                score += 0.5;
+            }
+            else
+            {
+                ++results.losses;
+            }
+        }
+        score /= 2.0;
+        results.score_sum += score;
+        results.score_sq_sum += score * score;
+    }
+    return results;
+}
+
+//------------------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        const auto usage = []
+        {
+            std::cerr <<
+                "Usage: tournament <player> <player> [n_deals] [seed] [n_threads]\n" <<
+                "A player is either 'random' or 'mc:<playouts per decision>'.\n" <<
+                "n_deals and n_threads must be positive.\n" <<
+                "Example:\n" <<
+                "    tournament mc:1024 random 1000\n";
+            return EXIT_FAILURE;
+        };
+        if(argc < 3 || argc > 6)
+        {
+            return usage();
+        }
+        const std::array<Player, 2> players{
+            parsePlayer(argv[1]), parsePlayer(argv[2])};
+        const int n_deals = argc > 3 ? std::atoi(argv[3]) : 1'000;
+        const auto seed = static_cast<std::uint32_t>(
+            argc > 4 ? std::atol(argv[4]) : 1);
+        const int n_threads = argc > 5
+            ? std::atoi(argv[5])
+            : std::max(1u, std::thread::hardware_concurrency());
+        if(n_deals <= 0 || n_threads <= 0)
+        {
+            return usage();
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        std::atomic<int> next_deal{0};
+        std::vector<Results> thread_results(n_threads);
+        std::vector<std::thread> threads;
+        for(int i = 0; i < n_threads; ++i)
+        {
+            threads.emplace_back([&, i]
+            {
+                thread_results[i] =
+                    worker<Briscola>(players, n_deals, seed, next_deal);
+            });
+        }
+        Results results;
+        for(int i = 0; i < n_threads; ++i)
+        {
+            threads[i].join();
+            results += thread_results[i];
+        }
+        const std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        // Normal approximation on the mean score of each deal.
+        const double mean = results.score_sum / n_deals;
+        const double var = std::max(0.0,
+            results.score_sq_sum / n_deals - mean * mean) * n_deals
+            / std::max(1, n_deals - 1);
+        const double ci = 1.96 * std::sqrt(var / n_deals);
+
+        std::cout << players[0].name << " vs " << players[1].name << ": "
+            << 2 * n_deals << " games (" << n_deals << " deals x 2 seats), "
+            << n_threads << " threads, " << elapsed.count() << " s\n"
+            << players[0].name << " score: " << mean << " +/- " << ci
+            << " (95% CI), " << results.wins << " wins, " << results.draws
+            << " draws, " << results.losses << " losses\n";
+        for(int i = 0; i < 2; ++i)
+        {
+            std::cout << players[i].name << " CPU time per decision: "
+                << results.cpu_ns[i] / std::max(1L, results.n_decisions[i]) / 1e3
+                << " us";
+            if(results.n_searches[i] > 0)
+            {
+                std::cout << ", per engine search: "
+                    << results.search_cpu_ns[i] / results.n_searches[i] / 1e3
+                    << " us (" << results.n_searches[i] << " of "
+                    << results.n_decisions[i] << " decisions)";
+            }
+            std::cout << '\n';
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,287 @@
+#pragma once
+
+// Low-overhead tracing of the request handling.
+// Spans are recorded in per-thread ring buffers and dumped in the
+// Chrome trace-event Json format, which can be opened with Perfetto
+// (https://ui.perfetto.dev) or chrome://tracing.
+// Tracing is off by default and can be switched on and off while
+// the server is running. When it is on, only one request every
+// `every` is sampled. Outside of a sampled request a span costs a
+// thread-local load.
+//
+// Usage:
+//     trace::Request request{"request"};  // Once per request.
+//     ...
+//     trace::Span span{"GameState::fromJson"};
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+
+namespace trace
+{
+
+// A completed span. Times are in nanoseconds since the start of
+// the program. The name must be a string literal without quotes
+// or backslashes, as it is not escaped when dumped.
+struct Event
+{
+    const char* name;
+    std::int64_t begin;
+    std::int64_t end;
+};
+
+
+// Ring buffer with the latest events recorded by a thread.
+// The mutex is only contended while the buffer is being dumped.
+class Buffer
+{
+public:
+    static constexpr std::size_t capacity = 1'024;
+
+    explicit Buffer(int tid)
+      : m_mutex{},
+        m_events{},
+        m_count{0},
+        m_tid{tid},
+        m_retired{false}
+    {}
+
+    void push(const Event& e)
+    {
+        std::lock_guard lock{m_mutex};
+        m_events[m_count++ % capacity] = e;
+    }
+
+    // Calls f on each event still in the buffer, oldest first, and
+    // empties the buffer.
+    template <class F>
+    void drain(F&& f)
+    {
+        std::lock_guard lock{m_mutex};
+        const std::uint64_t first = m_count > capacity ? m_count - capacity : 0;
+        for (std::uint64_t i = first; i < m_count; ++i)
+        {
+            f(m_events[i % capacity]);
+        }
+        m_count = 0;
+    }
+
+    int tid() const
+    {
+        return m_tid;
+    }
+
+    // A buffer is retired when its thread exits. Retired buffers
+    // are kept until they are dumped.
+    void retire()
+    {
+        m_retired.store(true, std::memory_order_release);
+    }
+
+    bool retired() const
+    {
+        return m_retired.load(std::memory_order_acquire);
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::array<Event, capacity> m_events;
+    std::uint64_t m_count;
+    const int m_tid;
+    std::atomic<bool> m_retired;
+};
+
+
+namespace detail
+{
+
+// The server starts a thread per connection: bound the number of
+// buffers of exited threads that are kept around if nobody dumps them.
+inline constexpr std::size_t max_retired = 64;
+
+inline const auto g_epoch = std::chrono::steady_clock::now();
+inline std::atomic<bool> g_enabled{false};
+inline std::atomic<unsigned> g_every{1};
+inline std::atomic<unsigned> g_counter{0};
+
+inline std::mutex g_mutex;
+inline std::vector<std::shared_ptr<Buffer>> g_buffers;
+inline int g_next_tid = 1;
+
+// Whether the request handled by this thread is sampled.
+inline thread_local bool t_sampled = false;
+
+// Owns the buffer of this thread, created on the first event.
+struct ThreadBuffer
+{
+    std::shared_ptr<Buffer> buffer;
+
+    ThreadBuffer()
+      : buffer{}
+    {}
+
+    ~ThreadBuffer()
+    {
+        if (buffer)
+        {
+            buffer->retire();
+        }
+    }
+};
+
+inline thread_local ThreadBuffer t_buffer;
+
+inline std::int64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - g_epoch).count();
+}
+
+inline std::shared_ptr<Buffer> makeBuffer()
+{
+    std::lock_guard lock{g_mutex};
+    // Drop the oldest buffers of exited threads beyond the limit.
+    std::size_t n_retired = std::ranges::count_if(
+        g_buffers, [](const auto& b) { return b->retired(); });
+    std::erase_if(g_buffers, [&n_retired](const auto& b)
+    {
+        if (n_retired > max_retired && b->retired())
+        {
+            --n_retired;
+            return true;
+        }
+        return false;
+    });
+    return g_buffers.emplace_back(std::make_shared<Buffer>(g_next_tid++));
+}
+
+inline void record(const Event& e)
+{
+    if (!t_buffer.buffer)
+    {
+        t_buffer.buffer = makeBuffer();
+    }
+    t_buffer.buffer->push(e);
+}
+
+} // namespace detail
+
+
+// Switches tracing on, sampling one request every `every`.
+inline void enable(const unsigned every = 1)
+{
+    detail::g_every.store(std::max(every, 1u), std::memory_order_relaxed);
+    detail::g_enabled.store(true, std::memory_order_relaxed);
+}
+
+inline void disable()
+{
+    detail::g_enabled.store(false, std::memory_order_relaxed);
+}
+
+inline bool enabled()
+{
+    return detail::g_enabled.load(std::memory_order_relaxed);
+}
+
+inline unsigned every()
+{
+    return detail::g_every.load(std::memory_order_relaxed);
+}
+
+// Writes all the recorded events in the Chrome trace-event Json
+// format and drains the buffers, so that each event is dumped only
+// once. Buffers of exited threads are released once dumped.
+inline void dump(std::ostream& os)
+{
+    std::lock_guard lock{detail::g_mutex};
+    const auto flags = os.flags();
+    const auto precision = os.precision();
+    os << std::fixed << std::setprecision(3);
+    os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    const char* sep = "";
+    for (const auto& buffer : detail::g_buffers)
+    {
+        buffer->drain([&os, &sep, &buffer](const Event& e)
+        {
+            // Complete events: timestamps and durations in microseconds.
+            os << sep << "{\"name\":\"" << e.name << "\",\"ph\":\"X\""
+                << ",\"ts\":" << e.begin / 1e3
+                << ",\"dur\":" << (e.end - e.begin) / 1e3
+                << ",\"pid\":1,\"tid\":" << buffer->tid() << '}';
+            sep = ",";
+        });
+    }
+    os << "]}";
+    os.flags(flags);
+    os.precision(precision);
+    std::erase_if(detail::g_buffers,
+        [](const auto& b) { return b->retired(); });
+}
+
+
+// Records the time spent between construction and destruction,
+// if the current request is sampled.
+class Span
+{
+public:
+    explicit Span(const char* name)
+      : m_name{name},
+        m_begin{detail::t_sampled ? detail::now() : -1}
+    {}
+
+    ~Span()
+    {
+        if (m_begin >= 0)
+        {
+            detail::record({m_name, m_begin, detail::now()});
+        }
+    }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+private:
+    const char* m_name;
+    const std::int64_t m_begin;
+};
+
+
+// Marks the handling of one request by the current thread: decides
+// whether the request is sampled and records a span covering it.
+class Request
+{
+public:
+    explicit Request(const char* name)
+      // The sampling decision must be taken before the span reads it.
+      : m_span{(sample(), name)}
+    {}
+
+    ~Request()
+    {
+        detail::t_sampled = false;
+    }
+
+    Request(const Request&) = delete;
+    Request& operator=(const Request&) = delete;
+
+private:
+    static void sample()
+    {
+        detail::t_sampled = enabled()
+            && detail::g_counter.fetch_add(1, std::memory_order_relaxed)
+                % every() == 0;
+    }
+
+    Span m_span;
+};
+
+} // namespace trace